@@ -38,6 +38,19 @@ enum class rapidDebug
   INFO
 };
 
+/**
+ * @brief rapidState type enum for the activation state
+ * of plugins started with runLazy
+ * 
+ */
+enum class rapidState
+{
+  INACTIVE,
+  STARTING,
+  ACTIVE,
+  SUSPENDING
+};
+
 /**
  * @brief rapidFunction type struct for messaging to
  * and from rapidPlugins
@@ -49,6 +62,121 @@ struct rapidFunction
   char parameters[48];
 };
 
+/**
+ * @brief Notification values sent to the task given to cmdFromISR once the
+ * command has been processed. Both are non-zero so they can be told apart from
+ * a notification timeout. The default notification index (0) is used
+ * 
+ */
+#define rapidRTOS_NOTIFY_RUN 1                  // Notification value when the function was run
+#define rapidRTOS_NOTIFY_UNKNOWN 2              // Notification value when the function is unknown
+
+#ifndef rapidRTOS_MAX_COALESCE
+#define rapidRTOS_MAX_COALESCE 4                // Max number of coalescable functions per rapidPlugin
+#endif
+
+#ifndef rapidRTOS_COALESCE_REPLY_TIMEOUT
+#define rapidRTOS_COALESCE_REPLY_TIMEOUT (10 / portTICK_PERIOD_MS) // Max ticks to wait per extra response of a coalesced command
+#endif
+
+/**
+ * @brief Critical section used to guard state shared between
+ * plugin tasks and the tasks sending commands to them
+ * 
+ */
+#ifdef BOARD_ESP32
+static portMUX_TYPE rapidRTOS_spinlock = portMUX_INITIALIZER_UNLOCKED;
+#define rapidRTOS_ENTER_CRITICAL() taskENTER_CRITICAL(&rapidRTOS_spinlock)
+#define rapidRTOS_EXIT_CRITICAL() taskEXIT_CRITICAL(&rapidRTOS_spinlock)
+#define rapidRTOS_ENTER_CRITICAL_FROM_ISR() portENTER_CRITICAL_ISR(&rapidRTOS_spinlock)
+#define rapidRTOS_EXIT_CRITICAL_FROM_ISR() portEXIT_CRITICAL_ISR(&rapidRTOS_spinlock)
+#else
+#define rapidRTOS_ENTER_CRITICAL() taskENTER_CRITICAL()
+#define rapidRTOS_EXIT_CRITICAL() taskEXIT_CRITICAL()
+// declares the saved interrupt state, so use at most once per scope
+#define rapidRTOS_ENTER_CRITICAL_FROM_ISR() UBaseType_t rapidRTOS_interruptStatus = taskENTER_CRITICAL_FROM_ISR()
+#define rapidRTOS_EXIT_CRITICAL_FROM_ISR() taskEXIT_CRITICAL_FROM_ISR(rapidRTOS_interruptStatus)
+#endif
+
+/**
+ * @brief rapidCoalesce type struct for tracking a coalescable
+ * function of a rapidPlugin. While a command for the function
+ * is queued but not yet started, newer commands for the same
+ * function replace it rather than being queued behind it. A
+ * command is only replaced while no other command for the
+ * function is queued after it, so commands never run out of order
+ * 
+ */
+struct rapidCoalesce
+{
+  const char* function;   // coalescable function name (NULL = unused)
+  const char* pending;    // newest queued command not yet started (NULL = none)
+  uint8_t queued;         // 1 = pending command is in the queue | 0 = still being sent
+  uint8_t waiters;        // callers waiting for the response of the pending command
+  uint8_t inflight;       // commands for the function queued on their own and not yet started
+  uint32_t sequence;      // incremented each time a new pending command is claimed
+  uint8_t running;        // callers still waiting for the response of the started command
+  uint32_t runningSeq;    // sequence of the started command
+  uint32_t count;         // number of commands replaced by a newer command
+};
+
+/**
+ * @brief rapidMemory type struct for tracking the heap
+ * usage attributed to a rapidPlugin
+ * 
+ */
+struct rapidMemory
+{
+  size_t current;         // bytes currently allocated by the plugin through rapidRTOS.alloc
+  size_t peak;            // peak bytes allocated by the plugin through rapidRTOS.alloc
+  size_t framework;       // bytes allocated by the framework for the plugin's tasks and queues
+};
+
+/**
+ * @brief rapidAllocation type struct stored ahead of each
+ * block returned by rapidRTOS.alloc to attribute the block
+ * to its owner when released
+ * 
+ */
+struct alignas(8) rapidAllocation
+{
+  rapidMemory* owner;     // memory usage the block is attributed to (NULL = no plugin)
+  size_t size;            // requested size of the block in bytes
+};
+
+/**
+ * @brief rapidActivation type struct used by the manager to
+ * create the tasks of a plugin started with runLazy when the
+ * first command arrives and to suspend them again once idle
+ * 
+ */
+struct rapidActivation
+{
+  BaseType_t (*start)(void*);   // creates or resumes the plugin's tasks (NULL = plugin not lazy)
+  void (*suspend)(void*);       // suspends the main task and deletes the interface task, keeping the queues
+  void* plugin;                 // plugin passed to start and suspend
+  TickType_t idleTimeout;       // ticks without commands before suspending (0 = never)
+  TickType_t lastActive;        // tick count of the last command serviced or touch()
+  uint32_t requested;           // micros() when activation was requested (0 = none)
+  uint32_t latency;             // micros from activation request to the first command serviced
+  rapidState state;             // current activation state
+  uint8_t busy;                 // 1 = a command is being serviced, never suspended while set
+};
+
+/**
+ * @brief rapidCommand type struct for queueing rapidFunction
+ * commands to the interface of a rapidPlugin
+ * 
+ */
+struct rapidCommand
+{
+  const char* command;    // string literal containing the rapidFunction command
+  TaskHandle_t notify;    // task notified with the result on completion (NULL = none)
+  uint8_t reply;          // 1 = response sent on the response queue | 0 = fire and forget
+  rapidCoalesce* coalesce;// coalesce entry of the command's function (NULL = not coalescable)
+  uint8_t ordered;        // 1 = queued on its own and counted in inflight | 0 = uses the pending command
+};
+
 #include "rapidRTOS_manager.h"
 
 #ifndef rapidRTOS_DEFAULT_STACK_SIZE
@@ -84,8 +212,15 @@ class rapidPlugin
     ~rapidPlugin();
     BaseType_t run(TaskFunction_t child, uint32_t stackDepth = rapidRTOS_DEFAULT_STACK_SIZE, uint32_t interfaceDepth = rapidRTOS_DEFAULT_INTERFACE_SIZE, int queueSize = rapidRTOS_DEFAULT_QUEUE_SIZE, UBaseType_t priority = rapidRTOS_DEFAULT_PRIORITY);
     BaseType_t runCore(UBaseType_t core, TaskFunction_t child, uint32_t stackDepth = rapidRTOS_DEFAULT_STACK_SIZE, uint32_t interfaceDepth = rapidRTOS_DEFAULT_INTERFACE_SIZE, int queueSize = rapidRTOS_DEFAULT_QUEUE_SIZE, UBaseType_t priority = rapidRTOS_DEFAULT_PRIORITY);
+    BaseType_t runLazy(TickType_t idleTimeout, TaskFunction_t child, uint32_t stackDepth = rapidRTOS_DEFAULT_STACK_SIZE, uint32_t interfaceDepth = rapidRTOS_DEFAULT_INTERFACE_SIZE, int queueSize = rapidRTOS_DEFAULT_QUEUE_SIZE, UBaseType_t priority = rapidRTOS_DEFAULT_PRIORITY);
     void stop();
     const char* cmd(const char* command, TickType_t timeout = portMAX_DELAY);
+    BaseType_t cmdFromISR(const char* command, TaskHandle_t notify = NULL);
+    uint8_t coalesce(const char* function);
+    void resetCoalesce();
+    uint32_t getCoalesceCount(const char* function);
+    rapidMemory getMemory();
+    uint32_t getActivationLatency();
     virtual uint8_t interface(rapidFunction incoming, char messageBuffer[]);
 
   protected:
@@ -95,7 +230,26 @@ class rapidPlugin
     TaskHandle_t _interfaceHandle = NULL; // interface task handle reference
     QueueHandle_t _taskQueue = NULL;      // interface task incoming queue
     QueueHandle_t _taskResponse = NULL;   // interface task outgoing queue
+    bool _inlineInterface = false;        // true = no interface task, commands serviced by the main task
+    char _messageBuffer[rapidRTOS_DEFAULT_INTERFACE_BUFFER] = ""; // interface response message buffer
+    rapidCoalesce _coalesce[rapidRTOS_MAX_COALESCE] = {};          // coalescable functions
+    rapidMemory _memory = {};                                       // heap usage attributed to the plugin
+    rapidActivation _activation = {};                               // lazy activation state
+    TaskFunction_t _child = NULL;         // main task function used by lazy activation
+    uint32_t _stackDepth = 0;             // main task stack depth used by lazy activation
+    uint32_t _interfaceDepth = 0;         // interface task stack depth used by lazy activation
+    int _queueSize = 0;                   // command queue size used by lazy activation
+    UBaseType_t _priority = 0;            // task priority used by lazy activation
+    size_t footprint(uint32_t stackDepth, uint32_t interfaceDepth, int queueSize);
+    uint8_t serviceCommands(TickType_t timeout = 0);
+    void touch();
+    #if ( configUSE_QUEUE_SETS == 1 )
+    BaseType_t addToQueueSet(QueueSetHandle_t queueSet);
+    bool isCommandQueue(QueueSetMemberHandle_t member);
+    #endif
     static void interface_loop(void*);
+    static BaseType_t activate_tasks(void*);
+    static void suspend_tasks(void*);
 };
 
 /**
@@ -117,7 +271,9 @@ rapidPlugin::~rapidPlugin()
 }
 
 /**
- * @brief Runs a rapidPlugin task and registers the task with the rapidRTOS manager
+ * @brief Runs a rapidPlugin task and registers the task with the rapidRTOS manager.
+ * If _inlineInterface is set no interface task is created and the main task
+ * must call serviceCommands() to process incoming rapidFunction commands
  * 
  * @param child reference to task of plugin
  * @param stackDepth stack depth of the task (stack size is target dependent)
@@ -132,21 +288,33 @@ BaseType_t rapidPlugin::run(TaskFunction_t child, uint32_t stackDepth, uint32_t
   interfaceDepth = interfaceDepth * 4;
   #endif
   sprintf(_iID, "i_%s", _pID);
-  if (!rapidRTOS.getTaskHandle(_pID))
+  if (!_taskQueue && !rapidRTOS.getTaskHandle(_pID))
   {
-    _taskQueue = xQueueCreate(queueSize, sizeof(const char*));
+    _taskQueue = xQueueCreate(queueSize, sizeof(rapidCommand));
     _taskResponse = xQueueCreate(1, sizeof(const char*));
-    if(xTaskCreate(child, _pID, stackDepth, this, priority, &_taskHandle)\
-    && xTaskCreate(&interface_loop, _iID, interfaceDepth, this, priority, &_interfaceHandle))\
-    return (BaseType_t)rapidRTOS.reg(_taskHandle, _pID, &_taskQueue, &_taskResponse);
+    resetCoalesce();
+    _memory.framework = footprint(stackDepth, interfaceDepth, queueSize);
+    // registered before the tasks are created so allocations made as they start are attributed
+    uint8_t registered = _taskQueue && _taskResponse\
+    && rapidRTOS.reg(NULL, _pID, &_taskQueue, &_taskResponse, _coalesce, &_memory, NULL, &_interfaceHandle, &_taskHandle);
+    BaseType_t created = registered\
+    && xTaskCreate(child, _pID, stackDepth, this, priority, &_taskHandle)\
+    && (_inlineInterface || xTaskCreate(&interface_loop, _iID, interfaceDepth, this, priority, &_interfaceHandle));
+    if (created)
+    {
+      rapidRTOS.setTaskHandle(_pID, _taskHandle);
+      return 1;
+    }
     else
     {
-      vTaskDelete(_taskHandle);
+      if (_taskHandle) { vTaskDelete(_taskHandle); }
       _taskHandle = NULL;
-      vQueueDelete(_taskQueue);
+      if (registered) { rapidRTOS.dereg(_pID); }
+      if (_taskQueue) { vQueueDelete(_taskQueue); }
       _taskQueue = NULL;
-      vQueueDelete(_taskResponse);
+      if (_taskResponse) { vQueueDelete(_taskResponse); }
       _taskResponse = NULL;
+      _memory.framework = 0;
     return 0;
     }
   }
@@ -154,7 +322,9 @@ BaseType_t rapidPlugin::run(TaskFunction_t child, uint32_t stackDepth, uint32_t
 }
 
 /**
- * @brief Runs a rapidPlugin task on the specified core and registers the task with the rapidRTOS manager
+ * @brief Runs a rapidPlugin task on the specified core and registers the task with the rapidRTOS manager.
+ * If _inlineInterface is set no interface task is created and the main task
+ * must call serviceCommands() to process incoming rapidFunction commands
  * 
  * @param core core id
  * @param child reference to task of plugin
@@ -170,35 +340,47 @@ BaseType_t rapidPlugin::runCore(UBaseType_t core, TaskFunction_t child, uint32_t
   interfaceDepth = interfaceDepth * 4;
   #endif
   sprintf(_iID, "i_%s", _pID);
-  if (!rapidRTOS.getTaskHandle(_pID))
+  if (!_taskQueue && !rapidRTOS.getTaskHandle(_pID))
   {
-    _taskQueue = xQueueCreate(queueSize, sizeof(const char*));
+    _taskQueue = xQueueCreate(queueSize, sizeof(rapidCommand));
     _taskResponse = xQueueCreate(1, sizeof(const char*));
+    resetCoalesce();
+    _memory.framework = footprint(stackDepth, interfaceDepth, queueSize);
+    // registered before the tasks are created so allocations made as they start are attributed
+    uint8_t registered = _taskQueue && _taskResponse\
+    && rapidRTOS.reg(NULL, _pID, &_taskQueue, &_taskResponse, _coalesce, &_memory, NULL, &_interfaceHandle, &_taskHandle);
     #ifdef BOARD_ESP32
-    if(xTaskCreatePinnedToCore(child, _pID, stackDepth, this, priority, &_taskHandle, core)\
-    && xTaskCreatePinnedToCore(&interface_loop, _iID, interfaceDepth, this, priority, &_interfaceHandle, core))\
-    return (BaseType_t)rapidRTOS.reg(_taskHandle, _pID, &_taskQueue, &_taskResponse);
+    BaseType_t created = registered\
+    && xTaskCreatePinnedToCore(child, _pID, stackDepth, this, priority, &_taskHandle, core)\
+    && (_inlineInterface || xTaskCreatePinnedToCore(&interface_loop, _iID, interfaceDepth, this, priority, &_interfaceHandle, core));
     #elif BOARD_TEENSY
-    if(xTaskCreate(child, _pID, stackDepth, this, priority, &_taskHandle)\
-    && xTaskCreate(&interface_loop, _iID, interfaceDepth, this, priority, &_interfaceHandle))\
-    return (BaseType_t)rapidRTOS.reg(_taskHandle, _pID, &_taskQueue, &_taskResponse);
+    BaseType_t created = registered\
+    && xTaskCreate(child, _pID, stackDepth, this, priority, &_taskHandle)\
+    && (_inlineInterface || xTaskCreate(&interface_loop, _iID, interfaceDepth, this, priority, &_interfaceHandle));
     #elif BOARD_STM32
-    if(xTaskCreate(child, _pID, stackDepth, this, priority, &_taskHandle)\
-    && xTaskCreate(&interface_loop, _iID, interfaceDepth, this, priority, &_interfaceHandle))\
-    return (BaseType_t)rapidRTOS.reg(_taskHandle, _pID, &_taskQueue, &_taskResponse);
+    BaseType_t created = registered\
+    && xTaskCreate(child, _pID, stackDepth, this, priority, &_taskHandle)\
+    && (_inlineInterface || xTaskCreate(&interface_loop, _iID, interfaceDepth, this, priority, &_interfaceHandle));
     #else
-    if(xTaskCreateAffinitySet(child, _pID, stackDepth, this, priority, core, &_taskHandle)\
-    && xTaskCreateAffinitySet(&interface_loop, _iID, interfaceDepth, this, priority, core, &_interfaceHandle))\
-    return (BaseType_t)rapidRTOS.reg(_taskHandle, _pID, &_taskQueue, &_taskResponse);
+    BaseType_t created = registered\
+    && xTaskCreateAffinitySet(child, _pID, stackDepth, this, priority, core, &_taskHandle)\
+    && (_inlineInterface || xTaskCreateAffinitySet(&interface_loop, _iID, interfaceDepth, this, priority, core, &_interfaceHandle));
     #endif
+    if (created)
+    {
+      rapidRTOS.setTaskHandle(_pID, _taskHandle);
+      return 1;
+    }
     else
     {
-      vTaskDelete(_taskHandle);
+      if (_taskHandle) { vTaskDelete(_taskHandle); }
       _taskHandle = NULL;
-      vQueueDelete(_taskQueue);
+      if (registered) { rapidRTOS.dereg(_pID); }
+      if (_taskQueue) { vQueueDelete(_taskQueue); }
       _taskQueue = NULL;
-      vQueueDelete(_taskResponse);
+      if (_taskResponse) { vQueueDelete(_taskResponse); }
       _taskResponse = NULL;
+      _memory.framework = 0;
     return 0;
     }
   }
@@ -206,21 +388,151 @@ BaseType_t rapidPlugin::runCore(UBaseType_t core, TaskFunction_t child, uint32_t
 }
 
 /**
- * @brief Stops a running task
+ * @brief Registers a rapidPlugin with the rapidRTOS manager without starting its tasks.
+ * The command queues are created straight away but the tasks are only created when
+ * the first command arrives. Once no command has been serviced for idleTimeout the
+ * manager suspends child and deletes the interface task to free its stack, and child
+ * resumes where it was on the next command. child is suspended at an arbitrary point,
+ * so anything it holds (e.g. a mutex) stays held until then. Idle suspension and
+ * activation from cmdFromISR are carried out by the manager task and are not
+ * available with rapidRTOS_DISABLE_MANAGER. Plugins with _inlineInterface set cannot
+ * be run lazily, as commands are already queued when their main task starts and a
+ * queue that is not empty cannot be added to a queue set
+ * 
+ * @param idleTimeout ticks without commands before the tasks are suspended (0 = never)
+ * @param child reference to task of plugin
+ * @param stackDepth stack depth of the task (stack size is target dependent)
+ * @param queueSize queue size for rapidFunction commands between plugins
+ * @param priority FreeRTOS task priority
+ * @return BaseType_t 1 = plugin registered | 0 = plugin failed to register
+ */
+BaseType_t rapidPlugin::runLazy(TickType_t idleTimeout, TaskFunction_t child, uint32_t stackDepth, uint32_t interfaceDepth, int queueSize, UBaseType_t priority)
+{
+  #ifdef BOARD_ESP32
+  stackDepth = stackDepth * 4;
+  interfaceDepth = interfaceDepth * 4;
+  #endif
+  sprintf(_iID, "i_%s", _pID);
+  if (_inlineInterface)
+  {
+    rapidRTOS.printDebug(1, rapidDebug::ERROR, "%s: runLazy not supported with _inlineInterface\n", _pID);
+    return 0;
+  }
+  if (!_taskQueue && !rapidRTOS.getTaskHandle(_pID))
+  {
+    _child = child;
+    _stackDepth = stackDepth;
+    _interfaceDepth = interfaceDepth;
+    _queueSize = queueSize;
+    _priority = priority;
+    _activation = { &activate_tasks, &suspend_tasks, this, idleTimeout, xTaskGetTickCount(), 0, 0, rapidState::INACTIVE, 0 };
+    _taskQueue = xQueueCreate(queueSize, sizeof(rapidCommand));
+    _taskResponse = xQueueCreate(1, sizeof(const char*));
+    resetCoalesce();
+    _memory.framework = footprint(0, 0, queueSize);
+    if (_taskQueue && _taskResponse\
+    && rapidRTOS.reg(NULL, _pID, &_taskQueue, &_taskResponse, _coalesce, &_memory, &_activation, &_interfaceHandle, &_taskHandle))\
+    return 1;
+    else
+    {
+      if (_taskQueue) { vQueueDelete(_taskQueue); }
+      _taskQueue = NULL;
+      if (_taskResponse) { vQueueDelete(_taskResponse); }
+      _taskResponse = NULL;
+      _memory.framework = 0;
+      _activation = {};
+    return 0;
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief Creates the interface task of a plugin started with runLazy and creates
+ * child on the first activation or resumes it afterwards. Called by the manager
+ * when a command arrives for the inactive plugin
+ * 
+ * @param pModule pointer to plugin object
+ * @return BaseType_t pdPASS = tasks running | pdFAIL = tasks failed to start
+ */
+BaseType_t rapidPlugin::activate_tasks(void* pModule)
+{
+  rapidPlugin* plugin = (rapidPlugin*)pModule;
+  uint8_t resume = plugin->_taskHandle != NULL; // child is kept suspended while idle
+  if((resume || xTaskCreate(plugin->_child, plugin->_pID, plugin->_stackDepth, plugin, plugin->_priority, &plugin->_taskHandle))\
+  && (plugin->_inlineInterface || xTaskCreate(&interface_loop, plugin->_iID, plugin->_interfaceDepth, plugin, plugin->_priority, &plugin->_interfaceHandle)))
+  {
+    plugin->_memory.framework = plugin->footprint(plugin->_stackDepth, plugin->_interfaceDepth, plugin->_queueSize);
+    rapidRTOS.setTaskHandle(plugin->_pID, plugin->_taskHandle);
+    if (resume) { vTaskResume(plugin->_taskHandle); }
+    return pdPASS;
+  }
+  suspend_tasks(pModule);
+  return pdFAIL;
+}
+
+/**
+ * @brief Suspends child and deletes the interface task of a plugin started with
+ * runLazy while keeping it registered. Called by the manager once the plugin has
+ * been idle for its timeout. The interface task is only deleted while it is not
+ * servicing a command, so it holds nothing. child may be at any point and is
+ * therefore only suspended, keeping its stack and anything it holds or allocated
+ * 
+ * @param pModule pointer to plugin object
+ */
+void rapidPlugin::suspend_tasks(void* pModule)
+{
+  rapidPlugin* plugin = (rapidPlugin*)pModule;
+  if (plugin->_interfaceHandle) { vTaskDelete(plugin->_interfaceHandle); }
+  plugin->_interfaceHandle = NULL;
+  if (plugin->_taskHandle)
+  {
+    vTaskSuspend(plugin->_taskHandle);
+    // the interface task is deleted and lazy plugins never set _inlineInterface
+    plugin->_memory.framework = plugin->footprint(plugin->_stackDepth, 0, plugin->_queueSize) - sizeof(StaticTask_t);
+  }
+  else
+  {
+    plugin->_memory.framework = plugin->footprint(0, 0, plugin->_queueSize);
+  }
+}
+
+/**
+ * @brief Stops a running task. The plugin's tasks are deleted before its queues
+ * so no task is left blocked on a deleted queue. If called from one of the
+ * plugin's own tasks (e.g. by the "stop" command) other tasks may still be
+ * waiting on the queues, so they are handed to the manager to be drained and
+ * deleted once unused, and the calling task is deleted last
  * 
  */
 void rapidPlugin::stop()
 {
-  if (_taskHandle)
+  if (_taskQueue)
   {
-    if (_interfaceHandle) { vTaskDelete(_interfaceHandle); }
-    vTaskDelete(_taskHandle);
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    TaskHandle_t taskHandle = _taskHandle;
+    TaskHandle_t interfaceHandle = _interfaceHandle;
     _taskHandle = NULL;
+    _interfaceHandle = NULL;
+    uint8_t selfStop = (self == taskHandle || self == interfaceHandle);
+    if (interfaceHandle && interfaceHandle != self) { vTaskDelete(interfaceHandle); }
+    if (taskHandle && taskHandle != self) { vTaskDelete(taskHandle); }
     rapidRTOS.dereg(_pID);
-    vQueueDelete(_taskQueue);
+    if (selfStop)
+    {
+      rapidRTOS.retire(_taskQueue, _taskResponse);
+    }
+    else
+    {
+      vQueueDelete(_taskQueue);
+      vQueueDelete(_taskResponse);
+    }
     _taskQueue = NULL;
-    vQueueDelete(_taskResponse);
     _taskResponse = NULL;
+    _memory.framework = 0;
+    _activation.state = rapidState::INACTIVE;
+    _activation.start = NULL;
+    if (selfStop) { vTaskDelete(NULL); }
   }
 }
 
@@ -233,10 +545,146 @@ void rapidPlugin::stop()
  */
 const char* rapidPlugin::cmd(const char* command, TickType_t timeout)
 {
-  xQueueSend(_taskQueue, &command, timeout);
-  const char* response = "";
-  xQueueReceive(_taskResponse, &response, timeout);
-  return response;
+  return rapidRTOS.cmd(_pID, command, timeout);
+}
+
+/**
+ * @brief Sends a rapidFunction command to the plugin from an interrupt service routine.
+ * The command is not waited on and no response is returned, however a task can
+ * optionally be notified once the command has been processed. The notification
+ * value (default index 0) is set to rapidRTOS_NOTIFY_RUN if the function was run
+ * or rapidRTOS_NOTIFY_UNKNOWN if the function is unknown.
+ * 
+ * @param command string literal containing the rapidFunction command
+ * @param notify task to notify on completion of the command (NULL = no notification)
+ * @return BaseType_t pdPASS = command queued | errQUEUE_FULL = command queue full or plugin not running
+ */
+BaseType_t rapidPlugin::cmdFromISR(const char* command, TaskHandle_t notify)
+{
+  if (!_taskQueue) { return errQUEUE_FULL; }
+  rapidCommand outgoing = { command, notify, 0, NULL, 0 };
+  BaseType_t higherPriorityTaskWoken = pdFALSE;
+  BaseType_t result = rapidRTOS.sendFromISR(_taskQueue, _coalesce, outgoing, &higherPriorityTaskWoken);
+  if (_activation.start && _activation.state != rapidState::ACTIVE)
+  {
+    rapidRTOS.activateFromISR(&_activation, &higherPriorityTaskWoken);
+  }
+  portYIELD_FROM_ISR(higherPriorityTaskWoken);
+  return result;
+}
+
+/**
+ * @brief Marks a function as coalescable. If a command for the function is
+ * sent while an earlier one is still waiting in the queue, the queued command
+ * is replaced by the newer one and all callers receive the response of the
+ * newer command. Commands sent with cmdFromISR are never coalesced, but a
+ * queued command is not replaced while one of them is queued behind it
+ * 
+ * @param function name of the function (e.g. "setLevel")
+ * @return uint8_t 1 = function marked coalescable | 0 = no space for function
+ */
+uint8_t rapidPlugin::coalesce(const char* function)
+{
+  for (size_t i = 0; i < rapidRTOS_MAX_COALESCE; i++)
+  {
+    if (_coalesce[i].function && !strcmp(_coalesce[i].function, function))
+    {
+      return 1;
+    }
+  }
+  for (size_t i = 0; i < rapidRTOS_MAX_COALESCE; i++)
+  {
+    if (!_coalesce[i].function)
+    {
+      _coalesce[i].function = function;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief Clears the queued command state of every coalescable function, used
+ * when new command queues are created so state left by commands lost with the
+ * old queues cannot stall coalescing. Replacement counts are kept
+ * 
+ */
+void rapidPlugin::resetCoalesce()
+{
+  rapidRTOS_ENTER_CRITICAL();
+  for (size_t i = 0; i < rapidRTOS_MAX_COALESCE; i++)
+  {
+    _coalesce[i].pending = NULL;
+    _coalesce[i].queued = 0;
+    _coalesce[i].waiters = 0;
+    _coalesce[i].inflight = 0;
+    _coalesce[i].running = 0;
+  }
+  rapidRTOS_EXIT_CRITICAL();
+}
+
+/**
+ * @brief Gets the number of commands for a coalescable function that were
+ * replaced by a newer command before being started
+ * 
+ * @param function name of the function
+ * @return uint32_t number of coalesced commands
+ */
+uint32_t rapidPlugin::getCoalesceCount(const char* function)
+{
+  for (size_t i = 0; i < rapidRTOS_MAX_COALESCE; i++)
+  {
+    if (_coalesce[i].function && !strcmp(_coalesce[i].function, function))
+    {
+      return _coalesce[i].count;
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief Gets the heap usage attributed to the plugin. Allocations made
+ * through rapidRTOS.alloc by the plugin's tasks are counted in current
+ * and peak, which persist across stop() and run() so leaks can be found
+ * 
+ * @return rapidMemory heap usage of the plugin
+ */
+rapidMemory rapidPlugin::getMemory()
+{
+  return _memory;
+}
+
+/**
+ * @brief Gets the time taken for a plugin started with runLazy to service its
+ * first command after being activated by it, measured on the last activation
+ * 
+ * @return uint32_t activation latency in microseconds
+ */
+uint32_t rapidPlugin::getActivationLatency()
+{
+  return _activation.latency;
+}
+
+/**
+ * @brief Calculates the heap allocated by the framework when running the plugin
+ * 
+ * @param stackDepth stack depth of the main task (as passed to xTaskCreate, 0 = tasks not created)
+ * @param interfaceDepth stack depth of the interface task (as passed to xTaskCreate)
+ * @param queueSize queue size for rapidFunction commands
+ * @return size_t bytes allocated for the plugin's tasks and queues
+ */
+size_t rapidPlugin::footprint(uint32_t stackDepth, uint32_t interfaceDepth, int queueSize)
+{
+  size_t bytes = 2 * sizeof(StaticQueue_t) + queueSize * sizeof(rapidCommand) + sizeof(const char*);
+  if (!stackDepth) { return bytes; }
+  if (_inlineInterface) { interfaceDepth = 0; }
+  else { bytes += sizeof(StaticTask_t); }
+  #ifdef BOARD_ESP32
+  bytes += sizeof(StaticTask_t) + stackDepth + interfaceDepth;
+  #else
+  bytes += sizeof(StaticTask_t) + (stackDepth + interfaceDepth) * sizeof(StackType_t);
+  #endif
+  return bytes;
 }
 
 /**
@@ -254,42 +702,185 @@ uint8_t rapidPlugin::interface(rapidFunction incoming, char messageBuffer[])
 }
 
 /**
- * @brief Interface loop used to process incoming rapidFunction commands
+ * @brief Receives and processes a single rapidFunction command from the command queue.
+ * Used by the interface task and by plugins running with _inlineInterface set, which
+ * should call this from their main loop between work items
  * 
- * @param pModule pointer to calling object
+ * @param timeout maximum wait time for an incoming command
+ * @return uint8_t 1 = command processed | 0 = no command received
  */
-void rapidPlugin::interface_loop(void* pModule)
+uint8_t rapidPlugin::serviceCommands(TickType_t timeout)
 {
-  rapidPlugin* plugin = (rapidPlugin*)pModule;
-  char messageBuffer[rapidRTOS_DEFAULT_INTERFACE_BUFFER] = "";
-  const char* incomingMessage = messageBuffer;
-  const char* outgoingMessage = messageBuffer;
-  for ( ;; )
+  rapidCommand incomingCommand;
+  if (!_taskQueue || !xQueuePeek(_taskQueue, &incomingCommand, timeout))
+  {
+    return 0;
+  }
+  _activation.busy = 1; // set before the command leaves the queue so the plugin always looks in use
+  xQueueReceive(_taskQueue, &incomingCommand, 0);
+  rapidCoalesce* running = NULL; // coalesce entry counting the callers of this command
+  _activation.lastActive = xTaskGetTickCount();
+  if (_activation.requested)
+  {
+    _activation.latency = micros() - _activation.requested;
+    _activation.requested = 0;
+  }
+  if (incomingCommand.coalesce && incomingCommand.ordered)
   {
-    xQueueReceive(plugin->_taskQueue, &incomingMessage, portMAX_DELAY);
-    sprintf(messageBuffer, ""); // clear message buffer for outgoing message
-    rapidFunction incoming = rapidRTOS.parse(incomingMessage);
-    do
+    rapidRTOS_ENTER_CRITICAL();
+    if (incomingCommand.coalesce->inflight)
     {
-      if (!strcmp(incoming.function, "identity"))
+      incomingCommand.coalesce->inflight--;
+    }
+    rapidRTOS_EXIT_CRITICAL();
+  }
+  else if (incomingCommand.coalesce)
+  {
+    rapidRTOS_ENTER_CRITICAL();
+    if (incomingCommand.coalesce->pending)
+    {
+      incomingCommand.command = incomingCommand.coalesce->pending;
+      incomingCommand.coalesce->running = incomingCommand.coalesce->waiters;
+      incomingCommand.coalesce->runningSeq = incomingCommand.coalesce->sequence;
+      running = incomingCommand.coalesce;
+    }
+    incomingCommand.coalesce->pending = NULL;
+    incomingCommand.coalesce->queued = 0;
+    incomingCommand.coalesce->waiters = 0;
+    rapidRTOS_EXIT_CRITICAL();
+  }
+  sprintf(_messageBuffer, ""); // clear message buffer for outgoing message
+  rapidFunction incoming = rapidRTOS.parse(incomingCommand.command);
+  uint32_t handled = rapidRTOS_NOTIFY_RUN;
+  uint8_t stopping = 0;
+  do
+  {
+    if (!strcmp(incoming.function, "identity"))
+    {
+      sprintf(_messageBuffer, "%s", _pID);
+      continue;
+    }
+    if (!strcmp(incoming.function, "stats"))
+    {
+      int length = 0;
+      for (size_t i = 0; i < rapidRTOS_MAX_COALESCE && length < rapidRTOS_DEFAULT_INTERFACE_BUFFER; i++)
       {
-        sprintf(messageBuffer, "%s", plugin->_pID);
-        continue;
+        if (_coalesce[i].function)
+        {
+          length += snprintf(_messageBuffer + length, rapidRTOS_DEFAULT_INTERFACE_BUFFER - length, "%s%s:%u", length ? "," : "", _coalesce[i].function, (unsigned int)_coalesce[i].count);
+        }
       }
-      if (!strcmp(incoming.function, "stop"))
+      if (_activation.start && length < rapidRTOS_DEFAULT_INTERFACE_BUFFER)
       {
-        plugin->stop();
-        break;
+        snprintf(_messageBuffer + length, rapidRTOS_DEFAULT_INTERFACE_BUFFER - length, "%sactivation:%uus", length ? "," : "", (unsigned int)_activation.latency);
       }
-      if (plugin->interface(incoming, messageBuffer))
+      continue;
+    }
+    if (!strcmp(incoming.function, "mem"))
+    {
+      snprintf(_messageBuffer, rapidRTOS_DEFAULT_INTERFACE_BUFFER, "current:%u,peak:%u,framework:%u", (unsigned int)_memory.current, (unsigned int)_memory.peak, (unsigned int)_memory.framework);
+      continue;
+    }
+    if (!strcmp(incoming.function, "stop"))
+    {
+      stopping = 1; // stopped after replying so the caller is not left waiting
+      continue;
+    }
+    if (interface(incoming, _messageBuffer))
+    {
+      continue;
+    }
+    sprintf(_messageBuffer, "unknown_function(%s)", incoming.function);
+    rapidRTOS.printDebug(1, rapidDebug::ERROR, "%s: unknown_function(%s)\n", _pID, incoming.function);
+    handled = rapidRTOS_NOTIFY_UNKNOWN;
+  } while (false);
+  if (incomingCommand.notify)
+  {
+    xTaskNotify(incomingCommand.notify, handled, eSetValueWithOverwrite);
+  }
+  if (incomingCommand.reply)
+  {
+    const char* outgoingMessage = _messageBuffer;
+    if (!running)
+    {
+      xQueueSend(_taskResponse, &outgoingMessage, portMAX_DELAY);
+    }
+    // callers of a coalesced command are counted at send time as they may time out while it runs
+    for (TickType_t wait = portMAX_DELAY; running; wait = rapidRTOS_COALESCE_REPLY_TIMEOUT)
+    {
+      rapidRTOS_ENTER_CRITICAL();
+      uint8_t remaining = running->running;
+      if (remaining)
       {
-        continue;
+        running->running--;
       }
-      sprintf(messageBuffer, "unknown_function(%s)", incoming.function);
-      rapidRTOS.printDebug(1, rapidDebug::ERROR, "%s: unknown_function(%s)\n", plugin->_pID, incoming.function);
-    } while (false);
-    outgoingMessage = messageBuffer;
-    xQueueSend(plugin->_taskResponse, &outgoingMessage, portMAX_DELAY);
+      rapidRTOS_EXIT_CRITICAL();
+      if (!remaining)
+      {
+        break;
+      }
+      xQueueSend(_taskResponse, &outgoingMessage, wait);
+    }
+  }
+  _activation.lastActive = xTaskGetTickCount();
+  _activation.busy = 0;
+  if (stopping)
+  {
+    stop();
+  }
+  return 1;
+}
+
+/**
+ * @brief Marks a plugin started with runLazy as in use, restarting its idle
+ * timeout. The idle timeout only sees commands, so a child task doing work of
+ * its own should call this periodically to avoid being suspended part way through
+ * 
+ */
+void rapidPlugin::touch()
+{
+  _activation.lastActive = xTaskGetTickCount();
+}
+
+#if ( configUSE_QUEUE_SETS == 1 )
+/**
+ * @brief Adds the plugin's command queue to a queue set so that a plugin running
+ * with _inlineInterface set can block on commands and its own data sources at once.
+ * The queue set length must include the queue size given to run()
+ * 
+ * @param queueSet queue set created by the plugin's main task
+ * @return BaseType_t pdPASS = added to queue set | pdFAIL = failed to add
+ */
+BaseType_t rapidPlugin::addToQueueSet(QueueSetHandle_t queueSet)
+{
+  return xQueueAddToSet(_taskQueue, queueSet);
+}
+
+/**
+ * @brief Checks if a queue set member returned by xQueueSelectFromSet is the
+ * plugin's command queue, in which case serviceCommands() should be called
+ * 
+ * @param member queue set member selected
+ * @return true member is the command queue
+ * @return false member is not the command queue
+ */
+bool rapidPlugin::isCommandQueue(QueueSetMemberHandle_t member)
+{
+  return member == _taskQueue;
+}
+#endif
+
+/**
+ * @brief Interface loop used to process incoming rapidFunction commands
+ * 
+ * @param pModule pointer to calling object
+ */
+void rapidPlugin::interface_loop(void* pModule)
+{
+  rapidPlugin* plugin = (rapidPlugin*)pModule;
+  for ( ;; )
+  {
+    plugin->serviceCommands(portMAX_DELAY);
   }
 }
 
@@ -25,12 +25,22 @@
 #ifndef rapidRTOS_MANAGER_STACK_SIZE
 /**
  * @brief Stack size used by the manager task. This can be increased
- * to accomodate increasing numbers of plugins and tasks.
+ * to accomodate increasing numbers of plugins and tasks. Like plugin
+ * stacks it is multiplied by 4 on ESP32 where stacks are sized in bytes.
  * 
  */
 #define rapidRTOS_MANAGER_STACK_SIZE 256
 #endif
 
+#ifndef rapidRTOS_MANAGER_PERIOD
+/**
+ * @brief Period in ticks at which the manager task checks plugins
+ * started with runLazy for pending commands and idle timeouts.
+ * 
+ */
+#define rapidRTOS_MANAGER_PERIOD (1000/portTICK_PERIOD_MS)
+#endif
+
 /**
  * @brief rapidRTOS manager class provides a 'singleton' class for a rapidRTOS
  * task management object. Using this class will allow for
@@ -46,9 +56,14 @@ class rapidRTOS_manager
       static rapidRTOS_manager* singleton = new rapidRTOS_manager();
       return *singleton;
     }
-    uint8_t reg(TaskHandle_t taskHandle, const char* taskName, QueueHandle_t* command, QueueHandle_t* response);
+    uint8_t reg(TaskHandle_t taskHandle, const char* taskName, QueueHandle_t* command, QueueHandle_t* response, rapidCoalesce* coalesce, rapidMemory* memory, rapidActivation* activation, TaskHandle_t* interfaceHandle, TaskHandle_t* mainHandle);
+    uint8_t setTaskHandle(const char* taskName, TaskHandle_t taskHandle);
     uint8_t dereg(const char* taskName);
     const char* cmd(const char* taskName, const char* command, TickType_t timeout = portMAX_DELAY);
+    BaseType_t cmdFromISR(const char* taskName, const char* command, TaskHandle_t notify = NULL);
+    void activateFromISR(rapidActivation* activation, BaseType_t* higherPriorityTaskWoken);
+    rapidCoalesce* findCoalesce(rapidCoalesce* coalesce, const char* command);
+    BaseType_t sendFromISR(QueueHandle_t queue, rapidCoalesce* coalesce, rapidCommand outgoing, BaseType_t* higherPriorityTaskWoken);
     uint8_t setDebugLevel(uint8_t debugLevel);
     uint8_t getDebugLevel();
     void setDebugStream(Stream* streamRef);
@@ -57,6 +72,13 @@ class rapidRTOS_manager
     TaskHandle_t getTaskHandle(const char* taskName);
     TaskStatus_t getTaskStatus(const char* taskName);
     uint8_t getNumTasks();
+    uint32_t getCoalesceCount(const char* taskName);
+    void* alloc(size_t size);
+    void release(void* block);
+    rapidMemory getMemory(const char* taskName);
+    size_t getFrameworkMemory();
+    uint32_t getActivationLatency(const char* taskName);
+    void retire(QueueHandle_t command, QueueHandle_t response);
     void printTaskStatus(const char* taskName);
     rapidFunction parse(const char* message);
 
@@ -71,9 +93,23 @@ class rapidRTOS_manager
     TaskHandle_t _taskHandles[rapidRTOS_MAX_MODULES];
     QueueHandle_t* _taskQueues[rapidRTOS_MAX_MODULES];
     QueueHandle_t* _responseQueues[rapidRTOS_MAX_MODULES];
+    rapidCoalesce* _coalesce[rapidRTOS_MAX_MODULES];
+    rapidMemory* _memory[rapidRTOS_MAX_MODULES];
+    TaskHandle_t* _interfaceHandles[rapidRTOS_MAX_MODULES];
+    TaskHandle_t* _mainHandles[rapidRTOS_MAX_MODULES];
+    rapidMemory* getCurrentMemory();
+    rapidActivation* _activation[rapidRTOS_MAX_MODULES];
+    uint8_t activate(uint8_t index);
+    uint8_t idle(uint8_t index);
+    void suspend(uint8_t index);
+    void supervise();
+    QueueHandle_t _retiredQueues[rapidRTOS_MAX_MODULES];
+    QueueHandle_t _retiredResponses[rapidRTOS_MAX_MODULES];
+    uint8_t _retiredReplies[rapidRTOS_MAX_MODULES];
+    void collect();
     uint8_t _debugLevel = 0;
     Stream* _debugStream = &Serial;
-    TaskHandle_t _managerHandle;
+    TaskHandle_t _managerHandle = NULL;
 };
 
 /**
@@ -86,10 +122,17 @@ rapidRTOS_manager::rapidRTOS_manager()
   for (size_t i = 0; i < rapidRTOS_MAX_MODULES; i++)
   {
     _taskNames[i] = "";
+    _retiredQueues[i] = NULL;
+    _retiredResponses[i] = NULL;
+    _retiredReplies[i] = 0;
   }
   #ifndef rapidRTOS_DISABLE_MANAGER
+  #ifdef BOARD_ESP32
+  xTaskCreate(managerTask, "rapidRTOS_manager", rapidRTOS_MANAGER_STACK_SIZE * 4, this, 1, &_managerHandle);
+  #else
   xTaskCreate(managerTask, "rapidRTOS_manager", rapidRTOS_MANAGER_STACK_SIZE, this, 1, &_managerHandle);
   #endif
+  #endif
 }
 
 /**
@@ -99,9 +142,14 @@ rapidRTOS_manager::rapidRTOS_manager()
  * @param taskHandle task reference
  * @param command command queue reference
  * @param response response queue reference
+ * @param coalesce coalescable function table of rapidRTOS_MAX_COALESCE entries
+ * @param memory heap usage attributed to the task
+ * @param activation lazy activation state of the task (NULL = task always running)
+ * @param interfaceHandle interface task reference (NULL = no interface task)
+ * @param mainHandle main task reference, matched by alloc() before setTaskHandle() publishes the handle (NULL = none)
  * @return uint8_t 1 = no space for task registration | 0 = pass
  */
-uint8_t rapidRTOS_manager::reg(TaskHandle_t taskHandle, const char* taskName, QueueHandle_t* command, QueueHandle_t* response = NULL)
+uint8_t rapidRTOS_manager::reg(TaskHandle_t taskHandle, const char* taskName, QueueHandle_t* command, QueueHandle_t* response = NULL, rapidCoalesce* coalesce = NULL, rapidMemory* memory = NULL, rapidActivation* activation = NULL, TaskHandle_t* interfaceHandle = NULL, TaskHandle_t* mainHandle = NULL)
 {
   for (size_t i = 0; i < rapidRTOS_MAX_MODULES; i++)
   {
@@ -111,6 +159,11 @@ uint8_t rapidRTOS_manager::reg(TaskHandle_t taskHandle, const char* taskName, Qu
       _taskHandles[i] = taskHandle;
       _taskQueues[i] = command;
       _responseQueues[i] = response;
+      _coalesce[i] = coalesce;
+      _memory[i] = memory;
+      _activation[i] = activation;
+      _interfaceHandles[i] = interfaceHandle;
+      _mainHandles[i] = mainHandle;
       return 1;
     }
   }
@@ -118,7 +171,8 @@ uint8_t rapidRTOS_manager::reg(TaskHandle_t taskHandle, const char* taskName, Qu
 }
 
 /**
- * @brief Unregisters the task defined by task name
+ * @brief Unregisters the task defined by task name. A warning is printed if
+ * the task still has heap allocated through alloc() as this is likely a leak
  * 
  * @param taskName string literal name of the task
  * @return uint8_t 1 = task unregistered | 0 = task not found
@@ -133,6 +187,15 @@ uint8_t rapidRTOS_manager::dereg(const char* taskName)
       _taskHandles[i] = NULL;
       _taskQueues[i] = NULL;
       _responseQueues[i] = NULL;
+      if (_memory[i] && _memory[i]->current)
+      {
+        printDebug(1, rapidDebug::WARNING, "%s: %u bytes still allocated\n", taskName, (unsigned int)_memory[i]->current);
+      }
+      _coalesce[i] = NULL;
+      _memory[i] = NULL;
+      _activation[i] = NULL;
+      _interfaceHandles[i] = NULL;
+      _mainHandles[i] = NULL;
       return 1;
     }
   }
@@ -140,7 +203,37 @@ uint8_t rapidRTOS_manager::dereg(const char* taskName)
 }
 
 /**
- * @brief Sends a command to the task defined by task name
+ * @brief Updates the task handle of a registered task, used when the tasks
+ * of a plugin started with runLazy are created or deleted
+ * 
+ * @param taskName string literal name of the task
+ * @param taskHandle task reference (NULL = task not running)
+ * @return uint8_t 1 = task handle updated | 0 = task not found
+ */
+uint8_t rapidRTOS_manager::setTaskHandle(const char* taskName, TaskHandle_t taskHandle)
+{
+  for (size_t i = 0; i < rapidRTOS_MAX_MODULES; i++)
+  {
+    if(!strcmp(_taskNames[i],taskName))
+    {
+      _taskHandles[i] = taskHandle;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief Sends a command to the task defined by task name. If the task marked
+ * the command's function as coalescable and a command for it is already queued
+ * and not yet started, the queued command is replaced instead of queueing another.
+ * While the earlier command is still waiting for space in the queue, or another
+ * command for the function has been queued on its own behind it, the new command
+ * is queued on its own so commands for the function always run in order.
+ * Tasks registered by runLazy are activated before the command is sent, and if
+ * activation fails the command is not sent and an empty response is returned.
+ * If the plugin is not active once the command is queued (e.g. it was being
+ * suspended) the manager task is woken to activate it without waiting a period
  * 
  * @param taskName string literal name of task
  * @param command string literal containing the command
@@ -154,14 +247,199 @@ const char* rapidRTOS_manager::cmd(const char* taskName, const char* command, Ti
   {
     if(!strcmp(_taskNames[i],taskName))
     {
-      xQueueSend(*_taskQueues[i], &command, timeout);
-      xQueueReceive(*_responseQueues[i], &response, timeout);
+      if (_activation[i] && _activation[i]->state == rapidState::INACTIVE && !activate(i))
+      {
+        break; // no task to service the command, do not queue it
+      }
+      rapidCommand outgoing = { command, NULL, 1, NULL, 0 };
+      rapidCoalesce* entry = findCoalesce(_coalesce[i], command);
+      uint8_t replaced = 0;
+      uint32_t sequence = 0;
+      if (entry)
+      {
+        rapidRTOS_ENTER_CRITICAL();
+        if (entry->pending && entry->queued && !entry->inflight)
+        {
+          entry->pending = command;
+          entry->count++;
+          entry->waiters++;
+          replaced = 1;
+        }
+        else if (!entry->pending)
+        {
+          entry->pending = command;
+          entry->queued = 0;
+          entry->waiters = 1;
+          entry->sequence++;
+        }
+        else
+        {
+          entry->inflight++; // queue this one on its own behind the earlier command
+          outgoing.ordered = 1;
+        }
+        sequence = entry->sequence;
+        rapidRTOS_EXIT_CRITICAL();
+      }
+      outgoing.coalesce = entry;
+      if (!replaced)
+      {
+        if (!xQueueSend(*_taskQueues[i], &outgoing, timeout))
+        {
+          if (entry)
+          {
+            rapidRTOS_ENTER_CRITICAL();
+            if (outgoing.ordered)
+            {
+              if (entry->inflight) { entry->inflight--; }
+            }
+            else
+            {
+              entry->pending = NULL;
+              entry->waiters = 0;
+            }
+            rapidRTOS_EXIT_CRITICAL();
+          }
+          break;
+        }
+        if (entry && !outgoing.ordered)
+        {
+          rapidRTOS_ENTER_CRITICAL();
+          if (entry->pending && entry->sequence == sequence)
+          {
+            entry->queued = 1;
+          }
+          rapidRTOS_EXIT_CRITICAL();
+        }
+      }
+      // a plugin suspending while the command was sent may have missed it, so wake the manager to activate it
+      if (_activation[i] && _activation[i]->state != rapidState::ACTIVE && _managerHandle)
+      {
+        xTaskNotifyGive(_managerHandle);
+      }
+      if (!xQueueReceive(*_responseQueues[i], &response, timeout) && entry && !outgoing.ordered)
+      {
+        rapidRTOS_ENTER_CRITICAL();
+        if (entry->pending && entry->sequence == sequence && entry->waiters)
+        {
+          entry->waiters--; // command not started yet, so no response is sent for this caller
+        }
+        else if (entry->runningSeq == sequence && entry->running)
+        {
+          entry->running--; // command running, so no further response is sent for this caller
+        }
+        rapidRTOS_EXIT_CRITICAL();
+      }
       break;
     }
   }
   return response;
 }
 
+/**
+ * @brief Sends a command to the task defined by task name from an interrupt
+ * service routine without waiting for a response
+ * 
+ * @param taskName string literal name of task
+ * @param command string literal containing the command
+ * @param notify task to notify on completion of the command (NULL = no notification)
+ * @return BaseType_t pdPASS = command queued | errQUEUE_FULL = queue full or task not found
+ */
+BaseType_t rapidRTOS_manager::cmdFromISR(const char* taskName, const char* command, TaskHandle_t notify)
+{
+  BaseType_t result = errQUEUE_FULL;
+  BaseType_t higherPriorityTaskWoken = pdFALSE;
+  for (size_t i = 0; i < rapidRTOS_MAX_MODULES; i++)
+  {
+    if(!strcmp(_taskNames[i],taskName))
+    {
+      rapidCommand outgoing = { command, notify, 0, NULL, 0 };
+      result = sendFromISR(*_taskQueues[i], _coalesce[i], outgoing, &higherPriorityTaskWoken);
+      if (_activation[i] && _activation[i]->state != rapidState::ACTIVE)
+      {
+        activateFromISR(_activation[i], &higherPriorityTaskWoken);
+      }
+      break;
+    }
+  }
+  portYIELD_FROM_ISR(higherPriorityTaskWoken);
+  return result;
+}
+
+/**
+ * @brief Finds the coalesce entry of a command's function
+ * 
+ * @param coalesce coalescable function table of rapidRTOS_MAX_COALESCE entries (NULL = none)
+ * @param command string literal containing the command
+ * @return rapidCoalesce* coalesce entry of the function | NULL = function not coalescable
+ */
+rapidCoalesce* rapidRTOS_manager::findCoalesce(rapidCoalesce* coalesce, const char* command)
+{
+  if (!coalesce || !coalesce[0].function)
+  {
+    return NULL;
+  }
+  rapidFunction function = parse(command);
+  for (size_t j = 0; j < rapidRTOS_MAX_COALESCE; j++)
+  {
+    if (coalesce[j].function && !strcmp(coalesce[j].function, function.function))
+    {
+      return &coalesce[j];
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @brief Queues a command from an interrupt service routine. Commands for a
+ * coalescable function are queued on their own and counted in the entry's
+ * inflight so a queued command ahead of them is no longer replaced
+ * 
+ * @param queue command queue of the plugin
+ * @param coalesce coalescable function table of the plugin (NULL = none)
+ * @param outgoing command to queue
+ * @param higherPriorityTaskWoken set to pdTRUE if a higher priority task was woken
+ * @return BaseType_t pdPASS = command queued | errQUEUE_FULL = queue full
+ */
+BaseType_t rapidRTOS_manager::sendFromISR(QueueHandle_t queue, rapidCoalesce* coalesce, rapidCommand outgoing, BaseType_t* higherPriorityTaskWoken)
+{
+  outgoing.coalesce = findCoalesce(coalesce, outgoing.command);
+  outgoing.ordered = outgoing.coalesce ? 1 : 0;
+  if (outgoing.coalesce)
+  {
+    rapidRTOS_ENTER_CRITICAL_FROM_ISR();
+    outgoing.coalesce->inflight++;
+    rapidRTOS_EXIT_CRITICAL_FROM_ISR();
+  }
+  BaseType_t result = xQueueSendFromISR(queue, &outgoing, higherPriorityTaskWoken);
+  if (!result && outgoing.coalesce)
+  {
+    rapidRTOS_ENTER_CRITICAL_FROM_ISR();
+    if (outgoing.coalesce->inflight) { outgoing.coalesce->inflight--; }
+    rapidRTOS_EXIT_CRITICAL_FROM_ISR();
+  }
+  return result;
+}
+
+/**
+ * @brief Requests activation of a plugin started with runLazy from an interrupt
+ * service routine. Tasks cannot be created from an ISR so the manager task is
+ * woken to create them
+ * 
+ * @param activation lazy activation state of the plugin
+ * @param higherPriorityTaskWoken set to pdTRUE if the manager task was woken
+ */
+void rapidRTOS_manager::activateFromISR(rapidActivation* activation, BaseType_t* higherPriorityTaskWoken)
+{
+  if (!activation->requested)
+  {
+    activation->requested = micros();
+  }
+  if (_managerHandle)
+  {
+    vTaskNotifyGiveFromISR(_managerHandle, higherPriorityTaskWoken);
+  }
+}
+
 /**
  * @brief Sets the debug level which is used to filter debug messages for printing
  * 
@@ -283,7 +561,9 @@ TaskHandle_t rapidRTOS_manager::getTaskHandle(const char* taskName)
 }
 
 /**
- * @brief Requests the task status of the task defined by the task name
+ * @brief Requests the task status of the task defined by the task name.
+ * A plugin registered by runLazy whose tasks have not been created yet is reported
+ * as eSuspended
  * 
  * @param taskName string literal containing task name
  * @return TaskStatus_t task status of the task if found
@@ -291,11 +571,22 @@ TaskHandle_t rapidRTOS_manager::getTaskHandle(const char* taskName)
 TaskStatus_t rapidRTOS_manager::getTaskStatus(const char* taskName)
 {
   TaskStatus_t taskstatus;
+  taskstatus.pcTaskName = "";
   uint8_t freestackspace;
   for (uint8_t i = 0 ; i < rapidRTOS_MAX_MODULES ; i++)
   {
     if(!strcmp(_taskNames[i],taskName))
     {
+      if (!_taskHandles[i])
+      {
+        taskstatus.pcTaskName = _taskNames[i];
+        taskstatus.eCurrentState = eSuspended;
+        taskstatus.pxStackBase = NULL;
+        taskstatus.ulRunTimeCounter = 0;
+        taskstatus.uxCurrentPriority = 0;
+        taskstatus.xTaskNumber = 0;
+        continue;
+      }
       #ifdef BOARD_ESP32
       taskstatus.pcTaskName = _taskNames[i];
       taskstatus.eCurrentState = eInvalid;
@@ -329,6 +620,370 @@ uint8_t rapidRTOS_manager::getNumTasks()
   return numTasks;
 }
 
+/**
+ * @brief Gets the total number of commands coalesced by the task defined by task name
+ * 
+ * @param taskName string literal containing the task name
+ * @return uint32_t number of commands replaced by a newer command before being started
+ */
+uint32_t rapidRTOS_manager::getCoalesceCount(const char* taskName)
+{
+  uint32_t count = 0;
+  for (uint8_t i = 0 ; i < rapidRTOS_MAX_MODULES ; i++)
+  {
+    if(!strcmp(_taskNames[i],taskName) && _coalesce[i])
+    {
+      for (size_t j = 0; j < rapidRTOS_MAX_COALESCE; j++)
+      {
+        count += _coalesce[i][j].count;
+      }
+    }
+  }
+  return count;
+}
+
+/**
+ * @brief Allocates a block from the FreeRTOS heap and attributes it to the
+ * plugin whose main or interface task is calling. Blocks must be released
+ * with release() rather than vPortFree
+ * 
+ * @param size size of the block in bytes
+ * @return void* pointer to the block | NULL = allocation failed
+ */
+void* rapidRTOS_manager::alloc(size_t size)
+{
+  rapidAllocation* allocation = (rapidAllocation*)pvPortMalloc(sizeof(rapidAllocation) + size);
+  if (!allocation)
+  {
+    return NULL;
+  }
+  allocation->owner = getCurrentMemory();
+  allocation->size = size;
+  if (allocation->owner)
+  {
+    rapidRTOS_ENTER_CRITICAL();
+    allocation->owner->current += size;
+    if (allocation->owner->current > allocation->owner->peak)
+    {
+      allocation->owner->peak = allocation->owner->current;
+    }
+    rapidRTOS_EXIT_CRITICAL();
+  }
+  return allocation + 1;
+}
+
+/**
+ * @brief Releases a block allocated by alloc() and removes it from the
+ * heap usage of the plugin it was attributed to
+ * 
+ * @param block pointer to the block (NULL is ignored)
+ */
+void rapidRTOS_manager::release(void* block)
+{
+  if (!block)
+  {
+    return;
+  }
+  rapidAllocation* allocation = (rapidAllocation*)block - 1;
+  if (allocation->owner)
+  {
+    rapidRTOS_ENTER_CRITICAL();
+    allocation->owner->current -= (allocation->size < allocation->owner->current) ? allocation->size : allocation->owner->current;
+    rapidRTOS_EXIT_CRITICAL();
+  }
+  vPortFree(allocation);
+}
+
+/**
+ * @brief Gets the heap usage of the task defined by task name
+ * 
+ * @param taskName string literal containing the task name
+ * @return rapidMemory heap usage of the task if found
+ */
+rapidMemory rapidRTOS_manager::getMemory(const char* taskName)
+{
+  rapidMemory memory = {};
+  for (uint8_t i = 0 ; i < rapidRTOS_MAX_MODULES ; i++)
+  {
+    if(!strcmp(_taskNames[i],taskName) && _memory[i])
+    {
+      memory = *_memory[i];
+    }
+  }
+  return memory;
+}
+
+/**
+ * @brief Gets the heap used by the framework, made up of the manager itself
+ * and the tasks and queues of every registered plugin
+ * 
+ * @return size_t bytes allocated by the framework
+ */
+size_t rapidRTOS_manager::getFrameworkMemory()
+{
+  size_t bytes = sizeof(rapidRTOS_manager);
+  #ifndef rapidRTOS_DISABLE_MANAGER
+  #ifdef BOARD_ESP32
+  bytes += sizeof(StaticTask_t) + rapidRTOS_MANAGER_STACK_SIZE * 4;
+  #else
+  bytes += sizeof(StaticTask_t) + rapidRTOS_MANAGER_STACK_SIZE * sizeof(StackType_t);
+  #endif
+  #endif
+  for (uint8_t i = 0 ; i < rapidRTOS_MAX_MODULES ; i++)
+  {
+    if(strcmp(_taskNames[i],"") && _memory[i])
+    {
+      bytes += _memory[i]->framework;
+    }
+  }
+  return bytes;
+}
+
+/**
+ * @brief Gets the time taken by a task registered by runLazy to service its
+ * first command after being activated by it
+ * 
+ * @param taskName string literal containing the task name
+ * @return uint32_t activation latency in microseconds of the last activation
+ */
+uint32_t rapidRTOS_manager::getActivationLatency(const char* taskName)
+{
+  for (uint8_t i = 0 ; i < rapidRTOS_MAX_MODULES ; i++)
+  {
+    if(!strcmp(_taskNames[i],taskName) && _activation[i])
+    {
+      return _activation[i]->latency;
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief Hands the queues of a plugin stopped from one of its own tasks to the
+ * manager. Other tasks may still be blocked on them, so the manager task drains
+ * the command queue, answers its callers with an empty response and deletes the
+ * queues once nothing is left waiting. Queues with responses that are never
+ * collected are kept rather than risk deleting a queue in use. Without the
+ * manager task (rapidRTOS_DISABLE_MANAGER) retired queues are never deleted
+ * 
+ * @param command command queue of the stopped plugin
+ * @param response response queue of the stopped plugin
+ */
+void rapidRTOS_manager::retire(QueueHandle_t command, QueueHandle_t response)
+{
+  for (uint8_t i = 0 ; i < rapidRTOS_MAX_MODULES ; i++)
+  {
+    if (!_retiredQueues[i])
+    {
+      _retiredResponses[i] = response;
+      _retiredReplies[i] = 0;
+      _retiredQueues[i] = command;
+      if (_managerHandle)
+      {
+        xTaskNotifyGive(_managerHandle);
+      }
+      return;
+    }
+  }
+  printDebug(1, rapidDebug::WARNING, "rapidRTOS_manager: no space to retire queues\n");
+}
+
+/**
+ * @brief Drains the queues handed over by retire(), answering any remaining
+ * callers, and deletes them once no caller can still be waiting on them
+ * 
+ */
+void rapidRTOS_manager::collect()
+{
+  for (uint8_t i = 0 ; i < rapidRTOS_MAX_MODULES ; i++)
+  {
+    if (!_retiredQueues[i])
+    {
+      continue;
+    }
+    rapidCommand incoming;
+    uint8_t drained = 0;
+    while (xQueueReceive(_retiredQueues[i], &incoming, 0))
+    {
+      drained = 1;
+      uint8_t replies = incoming.reply;
+      if (incoming.coalesce && incoming.ordered)
+      {
+        rapidRTOS_ENTER_CRITICAL();
+        if (incoming.coalesce->inflight) { incoming.coalesce->inflight--; }
+        rapidRTOS_EXIT_CRITICAL();
+      }
+      else if (incoming.coalesce)
+      {
+        rapidRTOS_ENTER_CRITICAL();
+        if (incoming.coalesce->pending)
+        {
+          replies = incoming.coalesce->waiters;
+        }
+        incoming.coalesce->pending = NULL;
+        incoming.coalesce->queued = 0;
+        incoming.coalesce->waiters = 0;
+        rapidRTOS_EXIT_CRITICAL();
+      }
+      if (incoming.notify)
+      {
+        xTaskNotify(incoming.notify, rapidRTOS_NOTIFY_UNKNOWN, eSetValueWithOverwrite);
+      }
+      _retiredReplies[i] += replies;
+    }
+    const char* response = "";
+    if (_retiredReplies[i] && xQueueSend(_retiredResponses[i], &response, 0))
+    {
+      _retiredReplies[i]--;
+    }
+    // a sender unblocked by draining copies its command when it next runs, so wait a pass
+    if (!drained && !_retiredReplies[i] && !uxQueueMessagesWaiting(_retiredResponses[i]))
+    {
+      vQueueDelete(_retiredQueues[i]);
+      vQueueDelete(_retiredResponses[i]);
+      _retiredQueues[i] = NULL;
+      _retiredResponses[i] = NULL;
+    }
+  }
+}
+
+/**
+ * @brief Creates or resumes the tasks of an inactive plugin registered by runLazy
+ * 
+ * @param index registration index of the plugin
+ * @return uint8_t 1 = plugin active or being started/suspended by another task | 0 = plugin failed to start
+ */
+uint8_t rapidRTOS_manager::activate(uint8_t index)
+{
+  rapidActivation* activation = _activation[index];
+  rapidRTOS_ENTER_CRITICAL();
+  if (activation->state != rapidState::INACTIVE)
+  {
+    rapidRTOS_EXIT_CRITICAL();
+    return 1;
+  }
+  activation->state = rapidState::STARTING;
+  rapidRTOS_EXIT_CRITICAL();
+  if (!activation->requested)
+  {
+    activation->requested = micros();
+  }
+  activation->lastActive = xTaskGetTickCount();
+  if (activation->start(activation->plugin))
+  {
+    activation->state = rapidState::ACTIVE;
+    printDebug(2, rapidDebug::INFO, "%s: activated\n", _taskNames[index]);
+    return 1;
+  }
+  activation->state = rapidState::INACTIVE;
+  printDebug(1, rapidDebug::ERROR, "%s: activation failed\n", _taskNames[index]);
+  return 0;
+}
+
+/**
+ * @brief Checks if a plugin registered by runLazy has been idle for longer than
+ * its idle timeout, with no command pending or being serviced
+ * 
+ * @param index registration index of the plugin
+ * @return uint8_t 1 = plugin idle | 0 = plugin in use or never idle
+ */
+uint8_t rapidRTOS_manager::idle(uint8_t index)
+{
+  rapidActivation* activation = _activation[index];
+  return activation->idleTimeout && !activation->busy\
+  && !uxQueueMessagesWaiting(*_taskQueues[index])\
+  && (TickType_t)(xTaskGetTickCount() - activation->lastActive) > activation->idleTimeout;
+}
+
+/**
+ * @brief Suspends the tasks of an active plugin registered by runLazy. The tasks
+ * are suspended first and the plugin is checked again, so a command taken or a
+ * touch() made in the meantime cancels the suspension. If a command arrived
+ * while suspending the plugin is activated again
+ * 
+ * @param index registration index of the plugin
+ */
+void rapidRTOS_manager::suspend(uint8_t index)
+{
+  rapidActivation* activation = _activation[index];
+  rapidRTOS_ENTER_CRITICAL();
+  if (activation->state != rapidState::ACTIVE || activation->busy)
+  {
+    rapidRTOS_EXIT_CRITICAL();
+    return;
+  }
+  activation->state = rapidState::SUSPENDING;
+  rapidRTOS_EXIT_CRITICAL();
+  TaskHandle_t taskHandle = _taskHandles[index];
+  TaskHandle_t interfaceHandle = _interfaceHandles[index] ? *_interfaceHandles[index] : NULL;
+  if (taskHandle) { vTaskSuspend(taskHandle); }
+  if (interfaceHandle) { vTaskSuspend(interfaceHandle); }
+  if (!idle(index))
+  {
+    if (interfaceHandle) { vTaskResume(interfaceHandle); }
+    if (taskHandle) { vTaskResume(taskHandle); }
+    activation->state = rapidState::ACTIVE;
+    return;
+  }
+  activation->suspend(activation->plugin);
+  activation->state = rapidState::INACTIVE;
+  printDebug(2, rapidDebug::INFO, "%s: suspended\n", _taskNames[index]);
+  if (uxQueueMessagesWaiting(*_taskQueues[index]))
+  {
+    activate(index);
+  }
+}
+
+/**
+ * @brief Activates plugins registered by runLazy that have pending commands
+ * and suspends those that have been idle longer than their idle timeout
+ * 
+ */
+void rapidRTOS_manager::supervise()
+{
+  for (uint8_t i = 0 ; i < rapidRTOS_MAX_MODULES ; i++)
+  {
+    if(!strcmp(_taskNames[i],"") || !_activation[i])
+    {
+      continue;
+    }
+    rapidActivation* activation = _activation[i];
+    if (activation->state == rapidState::INACTIVE && uxQueueMessagesWaiting(*_taskQueues[i]))
+    {
+      activate(i);
+    }
+    else if (activation->state == rapidState::ACTIVE && idle(i))
+    {
+      suspend(i);
+    }
+  }
+}
+
+/**
+ * @brief Finds the heap usage of the plugin owning the calling task,
+ * matching the calling task against each plugin's main and interface task.
+ * The plugin's own handle references are checked as well, so tasks that
+ * allocate before their handle is published are still attributed
+ * 
+ * @return rapidMemory* heap usage of the plugin | NULL = not a plugin task
+ */
+rapidMemory* rapidRTOS_manager::getCurrentMemory()
+{
+  TaskHandle_t current = xTaskGetCurrentTaskHandle();
+  for (uint8_t i = 0 ; i < rapidRTOS_MAX_MODULES ; i++)
+  {
+    if(_taskNames[i][0] != '\0')
+    {
+      if (_taskHandles[i] == current || (_mainHandles[i] && *_mainHandles[i] == current)\
+      || (_interfaceHandles[i] && *_interfaceHandles[i] == current))
+      {
+        return _memory[i];
+      }
+    }
+  }
+  return NULL;
+}
+
 /**
  * @brief Prints the current task status to the debug stream
  * 
@@ -337,6 +992,7 @@ uint8_t rapidRTOS_manager::getNumTasks()
 void rapidRTOS_manager::printTaskStatus(const char* taskName)
 {
   TaskStatus_t taskStatus = getTaskStatus(taskName);
+  rapidMemory memory = getMemory(taskName);
   const char * state = "";
   switch (taskStatus.eCurrentState)
   {
@@ -371,8 +1027,13 @@ Address:  %p\n\
 Runtime:  %d\n\
 Priority: %d\n\
 Task ID:  %d\n\
+Coalesce: %u\n\
+Heap:     %u\n\
+Peak:     %u\n\
+Overhead: %u\n\
+Latency:  %u\n\
 ***********************\n",\
-    taskStatus.pcTaskName, state, taskStatus.eCurrentState, taskStatus.pxStackBase, taskStatus.ulRunTimeCounter, taskStatus.uxCurrentPriority, taskStatus.xTaskNumber);
+    taskStatus.pcTaskName, state, taskStatus.eCurrentState, taskStatus.pxStackBase, taskStatus.ulRunTimeCounter, taskStatus.uxCurrentPriority, taskStatus.xTaskNumber, (unsigned int)getCoalesceCount(taskName), (unsigned int)memory.current, (unsigned int)memory.peak, (unsigned int)memory.framework, (unsigned int)getActivationLatency(taskName));
   }
   else
   {
@@ -383,8 +1044,13 @@ Address:  %p\n\
 Runtime:  %d\n\
 Priority: %d\n\
 Task ID:  %d\n\
+Coalesce: %u\n\
+Heap:     %u\n\
+Peak:     %u\n\
+Overhead: %u\n\
+Latency:  %u\n\
 ***********************\n",\
-    taskName, "Invalid", eInvalid, 0, 0, 0, 0);
+    taskName, "Invalid", eInvalid, 0, 0, 0, 0, 0, 0, 0, 0, 0);
   }
 }
 
@@ -444,7 +1110,9 @@ rapidFunction rapidRTOS_manager::parse(const char* message)
 }
 
 /**
- * @brief This is the manager's own task used to monitor critical tasks
+ * @brief This is the manager's own task used to monitor critical tasks and
+ * to activate and suspend plugins started with runLazy. The task wakes every
+ * rapidRTOS_MANAGER_PERIOD or when notified by activateFromISR
  * 
  * @param pParameters void* pointer to calling object
  */
@@ -454,7 +1122,9 @@ void rapidRTOS_manager::managerTask(void* pParameters)
   for (;;)
   {
     plugin->printDebug(255, rapidDebug::INFO, "Running in ULTRA debug mode");
-    vTaskDelay(1000/portTICK_PERIOD_MS);
+    plugin->supervise();
+    plugin->collect();
+    ulTaskNotifyTake(pdTRUE, rapidRTOS_MANAGER_PERIOD);
   }
 }
 